@@ -0,0 +1,111 @@
+#include "../log/log.h"
+#include "../reactor/timer.h"
+#include <chrono>
+#include <cstdio>
+#include <sys/resource.h>
+#include <thread>
+
+// 多个生产者线程同时 plan 定时器的吞吐，定时器都在一小时后到期，不会触发
+// timerfd 列是默认的 Reactor::plan，每个定时器一次 timerfd_create 加 mutex_
+// slack 列用 slack 避开 timerfd_create，只剩 mutex_ 的开销
+// 三列都关闭 INFO/WARNING 日志，否则 Reactor::plan/cancel 的日志会主导耗时
+// 分片只减少锁竞争，是否随线程数扩展要在多核机器上测；
+// 单核上线程是轮流执行的，结果只反映单次 plan 的开销，不能说明扩展性
+
+static constexpr int Per_Thread = 20000;
+
+template <class F> static double run(int threads, int per_thread, F plan) {
+  std::vector<std::thread> producers;
+  auto start = std::chrono::steady_clock::now();
+  for (int t = 0; t < threads; t++) {
+    producers.emplace_back([&plan, per_thread]() {
+      for (int i = 0; i < per_thread; i++) {
+        plan(i);
+      }
+    });
+  }
+  for (auto &p : producers) {
+    p.join();
+  }
+  std::chrono::duration<double> cost = std::chrono::steady_clock::now() - start;
+  return threads * per_thread / cost.count();
+}
+
+int main() {
+  log_init();
+  FLAGS_minloglevel = google::GLOG_ERROR;
+  x::Eventloop::Reactor r(20, x::time::Gap::Seconds(1));
+  x::Eventloop::TimerService ts(r, 32);
+  auto later = x::time::Stamp::Now() + x::time::Gap::Hours(1);
+
+  // timerfd 列每个定时器占一个fd，按fd上限缩减每线程的数量
+  struct rlimit rl;
+  getrlimit(RLIMIT_NOFILE, &rl);
+  rl.rlim_cur = rl.rlim_max;
+  setrlimit(RLIMIT_NOFILE, &rl);
+  int fd_budget = std::min<rlim_t>(rl.rlim_cur, 1 << 20) - 64;
+
+  auto cores = std::thread::hardware_concurrency();
+  printf("%u cores\n", cores);
+  if (cores < 2) {
+    printf("single core: numbers show per-call cost only, not scaling\n");
+  }
+  printf("%8s %20s %20s %20s\n", "threads", "timerfd plan/s",
+         "slack plan/s", "TimerService::plan/s");
+  for (int threads = 1; threads <= 32; threads *= 2) {
+    auto exact_per_thread = std::min(Per_Thread, fd_budget / threads);
+    std::vector<std::vector<x::Eventloop::Fd>> exact(threads);
+    std::atomic<int> next{0};
+    auto exact_rate = run(threads, exact_per_thread, [&](int i) {
+      thread_local int index = -1;
+      if (i == 0) {
+        index = next++;
+      }
+      exact[index].push_back(r.plan([]() {}, later));
+    });
+
+    std::vector<std::vector<x::Eventloop::Fd>> fds(threads);
+    next = 0;
+    auto reactor_rate = run(threads, Per_Thread, [&](int i) {
+      thread_local int index = -1;
+      if (i == 0) {
+        index = next++;
+      }
+      fds[index].push_back(r.plan([]() {}, later, x::time::Gap::InValid(),
+                                  x::time::Gap::MilliSeconds(10)));
+    });
+
+    std::vector<std::vector<x::Eventloop::Timer>> timers(threads);
+    next = 0;
+    auto service_rate = run(threads, Per_Thread, [&](int i) {
+      thread_local int index = -1;
+      if (i == 0) {
+        index = next++;
+      }
+      timers[index].push_back(ts.plan([]() {}, later));
+    });
+
+    printf("%8d %20.0f %20.0f %20.0f\n", threads, exact_rate, reactor_rate,
+           service_rate);
+
+    // cancel 不关闭 timerfd
+    for (const auto &v : exact) {
+      for (auto f : v) {
+        r.cancel(f);
+        close(f);
+      }
+    }
+    for (const auto &v : fds) {
+      for (auto f : v) {
+        r.cancel(f);
+      }
+    }
+    for (const auto &v : timers) {
+      for (const auto &t : v) {
+        ts.cancel(t);
+      }
+    }
+  }
+
+  log_finish();
+}
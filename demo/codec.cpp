@@ -0,0 +1,176 @@
+#include "../log/log.h"
+#include "../reactor/codec.h"
+#include <climits>
+#include <cstdio>
+#include <fcntl.h>
+#include <sys/socket.h>
+
+// 各编解码器逐字节喂入时能完整还原，边界上 NeedMore/TooLarge/Malformed 正确
+// FrameWriter 在发送缓冲写满后能从断点继续
+
+using x::Eventloop::Decode;
+
+static int failed = 0;
+
+static void check(bool ok, const char *what) {
+  printf("%-48s %s\n", what, ok ? "ok" : "FAILED");
+  failed += !ok;
+}
+
+static std::string encode_all(const x::Eventloop::Codec &c,
+                              const std::vector<std::string> &payloads) {
+  std::string out;
+  for (const auto &p : payloads) {
+    x::Eventloop::Encoded e;
+    c.encode(p, e);
+    for (int i = 0; i < e.iovcnt; i++) {
+      out.append(static_cast<char *>(e.iov[i].iov_base), e.iov[i].iov_len);
+    }
+  }
+  return out;
+}
+
+// 模拟每次只读到一个字节，消费掉的数据从缓冲头部移除
+static bool round_trip(x::Eventloop::Codec &c,
+                       const std::vector<std::string> &payloads) {
+  auto stream = encode_all(c, payloads);
+  std::string buffer;
+  std::vector<std::string> got;
+  for (auto ch : stream) {
+    buffer.push_back(ch);
+    std::vector<std::string_view> frames;
+    Decode status;
+    auto consumed = c.decode_all(buffer, frames, status);
+    if (status != Decode::NeedMore) {
+      return false;
+    }
+    got.insert(got.end(), frames.begin(), frames.end());
+    buffer.erase(0, consumed);
+  }
+  c.reset();
+  return buffer.empty() && got == payloads;
+}
+
+static Decode decode(x::Eventloop::Codec &c, const std::string &in,
+                     size_t *consumed = nullptr) {
+  std::string_view frame;
+  size_t n = 0;
+  auto ret = c.decode(in, frame, n);
+  c.reset();
+  if (consumed) {
+    *consumed = n;
+  }
+  return ret;
+}
+
+static bool resume_after_full_buffer() {
+  int sv[2];
+  if (socketpair(AF_UNIX, SOCK_STREAM, 0, sv) == -1) {
+    return false;
+  }
+  fcntl(sv[0], F_SETFL, O_NONBLOCK);
+  int size = 4096;
+  setsockopt(sv[0], SOL_SOCKET, SO_SNDBUF, &size, sizeof(size));
+
+  // 帧数超过 IOV_MAX，总大小远超发送缓冲
+  x::Eventloop::LengthCodec c(4, 1 << 20);
+  x::Eventloop::FrameWriter w(c);
+  std::vector<std::string> payloads;
+  for (int i = 0; i < IOV_MAX * 2; i++) {
+    payloads.push_back(std::string(i % 500, 'a' + i % 26));
+  }
+  for (const auto &p : payloads) {
+    w.push(p);
+  }
+
+  std::string in;
+  ssize_t frames = 0;
+  int writes = 0;
+  while (w.pending()) {
+    auto n = w.write(sv[0]);
+    if (n == -1) {
+      break;
+    }
+    frames += n;
+    writes++;
+    char buf[65536];
+    ssize_t r;
+    while ((r = recv(sv[1], buf, sizeof(buf), MSG_DONTWAIT)) > 0) {
+      in.append(buf, r);
+    }
+  }
+  close(sv[0]);
+  close(sv[1]);
+
+  std::vector<std::string_view> got;
+  Decode status;
+  auto consumed = c.decode_all(in, got, status);
+  return writes > 1 && frames == static_cast<ssize_t>(payloads.size()) &&
+         consumed == in.size() &&
+         std::vector<std::string>(got.begin(), got.end()) == payloads;
+}
+
+int main() {
+  log_init("codec");
+
+  std::vector<std::string> payloads{"", "a", "hello", std::string(300, 'x'),
+                                    std::string(70000, 'y')};
+  x::Eventloop::LengthCodec length(4, 1 << 20);
+  x::Eventloop::VarintCodec varint(1 << 20);
+  x::Eventloop::DelimiterCodec delimiter('\n', 1 << 20);
+  x::Eventloop::FixedCodec fixed(3);
+  check(round_trip(length, payloads), "length round trip, byte by byte");
+  check(round_trip(varint, payloads), "varint round trip, byte by byte");
+  check(round_trip(delimiter, payloads), "delimiter round trip, byte by byte");
+  check(round_trip(fixed, {"abc", "def", "ghi"}),
+        "fixed round trip, byte by byte");
+
+  // 长度恰好等于 max_frame 可以通过，再多一个字节即 TooLarge
+  x::Eventloop::LengthCodec length2(2, 100);
+  check(decode(length2, std::string("\0", 1)) == Decode::NeedMore,
+        "length: partial header needs more");
+  check(decode(length2, std::string("\0d", 2) + std::string(99, 'z')) ==
+            Decode::NeedMore,
+        "length: 99 of 100 bytes needs more");
+  check(decode(length2, std::string("\0d", 2) + std::string(100, 'z')) ==
+            Decode::Ok,
+        "length: max_frame accepted");
+  check(decode(length2, std::string("\0e", 2)) == Decode::TooLarge,
+        "length: max_frame + 1 too large");
+
+  x::Eventloop::VarintCodec varint2(300);
+  check(decode(varint2, "\x80") == Decode::NeedMore,
+        "varint: partial header needs more");
+  check(decode(varint2, "\xac\x02" + std::string(300, 'z')) == Decode::Ok,
+        "varint: max_frame accepted");
+  check(decode(varint2, "\xad\x02") == Decode::TooLarge,
+        "varint: max_frame + 1 too large");
+
+  // 第10个字节之后 uint64 已放不下
+  x::Eventloop::VarintCodec huge(SIZE_MAX);
+  size_t consumed = 0;
+  check(decode(huge, std::string(9, '\x80') + '\0', &consumed) == Decode::Ok &&
+            consumed == 10,
+        "varint: 10 byte header accepted");
+  check(decode(huge, std::string(9, '\x80') + '\x02') == Decode::Malformed,
+        "varint: bits past 64 malformed");
+  check(decode(huge, std::string(10, '\x80')) == Decode::Malformed,
+        "varint: 11th byte malformed");
+
+  x::Eventloop::DelimiterCodec delimiter2('\n', 5);
+  check(decode(delimiter2, "abcde") == Decode::NeedMore,
+        "delimiter: max_frame bytes needs more");
+  check(decode(delimiter2, "abcdef") == Decode::TooLarge,
+        "delimiter: max_frame + 1 too large");
+  check(decode(delimiter2, "abcde\n") == Decode::Ok,
+        "delimiter: max_frame accepted");
+
+  x::Eventloop::FixedCodec fixed2(4);
+  check(decode(fixed2, "abc") == Decode::NeedMore, "fixed: short needs more");
+  check(decode(fixed2, "abcd") == Decode::Ok, "fixed: exact size accepted");
+
+  check(resume_after_full_buffer(), "frame writer resumes after full buffer");
+
+  log_finish();
+  return failed ? 1 : 0;
+}
@@ -0,0 +1,70 @@
+#include "../log/log.h"
+#include "../reactor/file.h"
+#include <cstdio>
+#include <cstdlib>
+#include <fcntl.h>
+
+// 写入、fsync、读回的数据应一致，回调都在 Reactor 线程执行
+// FileIO 析构时已提交请求的回调不会丢
+
+int main() {
+  log_init("file_io");
+
+  char path[] = "/tmp/file_io_XXXXXX";
+  int fd = mkstemp(path);
+  if (fd == -1) {
+    return 1;
+  }
+  unlink(path);
+
+  x::Eventloop::Reactor r(20, x::time::Gap::Seconds(1));
+  std::string data(100000, 'x');
+  for (size_t i = 0; i < data.size(); i++) {
+    data[i] = 'a' + i % 26;
+  }
+  std::string back(data.size(), '\0');
+  ssize_t wrote = -1, synced = -1, got = -1;
+  bool on_loop = true;
+
+  {
+    x::Eventloop::FileIO io(r, 4);
+    auto owner = std::this_thread::get_id();
+    io.write_at(fd, data.data(), data.size(), 0, [&](ssize_t n) {
+      wrote = n;
+      on_loop &= std::this_thread::get_id() == owner;
+      io.fsync(fd, [&](ssize_t n) {
+        synced = n;
+        on_loop &= std::this_thread::get_id() == owner;
+        io.read_at(fd, &back[0], back.size(), 0, [&](ssize_t n) {
+          got = n;
+          on_loop &= std::this_thread::get_id() == owner;
+          r.stop();
+        });
+      });
+    });
+    r.run();
+  }
+  printf("write %zd, fsync %zd, read %zd, data %s, callbacks %s\n", wrote,
+         synced, got, back == data ? "match" : "differ",
+         on_loop ? "on loop thread" : "off loop thread");
+  auto ok = wrote == static_cast<ssize_t>(data.size()) && synced == 0 &&
+            got == static_cast<ssize_t>(data.size()) && back == data &&
+            on_loop;
+
+  // 不运行事件循环，回调应在析构中执行
+  int done = 0;
+  {
+    x::Eventloop::FileIO io(r, 2);
+    for (int i = 0; i < 8; i++) {
+      io.read_at(fd, &back[0], 16, i * 16, [&done](ssize_t n) {
+        done += n == 16;
+      });
+    }
+  }
+  printf("8 reads without running the loop: %d completed in destructor\n",
+         done);
+
+  close(fd);
+  log_finish();
+  return ok && done == 8 ? 0 : 1;
+}
@@ -0,0 +1,82 @@
+#include "../log/log.h"
+#include "../reactor/reactor.h"
+#include <cstdio>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+
+// 一轮分发中对同一fd的多次 send 应只产生一次写
+// socket 走 sendmsg，其他fd走 writev，覆盖 libc 的实现以计数，再直接走系统调用
+// 对端已关闭时不能因 SIGPIPE 退出
+
+static int write_calls = 0;
+
+extern "C" ssize_t writev(int fd, const struct iovec *iov, int iovcnt) {
+  write_calls++;
+  return syscall(SYS_writev, fd, iov, iovcnt);
+}
+
+extern "C" ssize_t sendmsg(int fd, const struct msghdr *msg, int flags) {
+  write_calls++;
+  return syscall(SYS_sendmsg, fd, msg, flags);
+}
+
+int main() {
+  log_init("output_cork");
+
+  int sv[2];
+  if (socketpair(AF_UNIX, SOCK_STREAM, 0, sv) == -1) {
+    return 1;
+  }
+  fcntl(sv[0], F_SETFL, O_NONBLOCK);
+  fcntl(sv[1], F_SETFL, O_NONBLOCK);
+
+  x::Eventloop::Reactor r(20, x::time::Gap::Seconds(1));
+
+  // 每收到一个请求字节回三个小响应
+  r.add(sv[0], x::Eventloop::Read, [&r, &sv]() {
+    char buf[64];
+    auto n = read(sv[0], buf, sizeof(buf));
+    for (ssize_t i = 0; i < n; i++) {
+      r.send(sv[0], "ok");
+      r.send(sv[0], ":");
+      r.send(sv[0], std::string("1\n"));
+    }
+  });
+
+  std::string reply;
+  r.add(sv[1], x::Eventloop::Read, [&r, &sv, &reply]() {
+    char buf[256];
+    auto n = read(sv[1], buf, sizeof(buf));
+    if (n > 0) {
+      reply.append(buf, n);
+    }
+    if (reply.size() == 4 * 5) {
+      r.stop();
+    }
+  });
+
+  // 四个流水线请求一次到达
+  write(sv[1], "abcd", 4);
+  r.run();
+
+  printf("12 sends for 4 pipelined requests: %d writes, reply %zu bytes\n",
+         write_calls, reply.size());
+  auto ok = write_calls == 1 && reply == "ok:1\nok:1\nok:1\nok:1\n";
+
+  // 对端关闭后再写，输出被丢弃而进程继续运行
+  r.del(sv[1]);
+  close(sv[1]);
+  r.plan([&r, &sv]() { r.send(sv[0], "late"); },
+         x::time::Stamp::Now() + x::time::Gap::MilliSeconds(10));
+  r.plan([&r]() { r.stop(); },
+         x::time::Stamp::Now() + x::time::Gap::MilliSeconds(50));
+  r.run();
+  printf("write to closed peer survived\n");
+
+  r.del(sv[0]);
+  close(sv[0]);
+  log_finish();
+  return ok ? 0 : 1;
+}
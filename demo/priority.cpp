@@ -0,0 +1,61 @@
+#include "../log/log.h"
+#include "../reactor/reactor.h"
+#include <cstdio>
+#include <sys/eventfd.h>
+#include <thread>
+
+// 预算 5ms，Normal 回调每次 6ms 且持续可读，Bulk 同样持续可读
+// 应满足: 同时就绪时 Normal 先于 Bulk；Bulk 仍能推进；心跳延迟有界
+
+int main() {
+  log_init("priority");
+  x::Eventloop::Reactor r(20, x::time::Gap::Seconds(1),
+                          x::time::Gap::MilliSeconds(5));
+
+  // eventfd 不读就一直可读
+  int normal_fd = eventfd(1, EFD_NONBLOCK);
+  int bulk_fd = eventfd(1, EFD_NONBLOCK);
+
+  int normal = 0, bulk = 0;
+  char first = 0;
+  r.add(normal_fd, x::Eventloop::Read, [&normal, &first]() {
+    if (!first) {
+      first = 'N';
+    }
+    normal++;
+    std::this_thread::sleep_for(std::chrono::milliseconds(6));
+  });
+  r.add(
+      bulk_fd, x::Eventloop::Read,
+      [&bulk, &first]() {
+        if (!first) {
+          first = 'B';
+        }
+        bulk++;
+      },
+      x::Eventloop::Bulk);
+
+  uint64_t last = 0, max_gap = 0;
+  auto start = x::time::Stamp::Now();
+  r.plan(
+      [&last, &max_gap]() {
+        auto now = x::time::Stamp::Now().MilliSecondsSinceEpoch();
+        if (last && now - last > max_gap) {
+          max_gap = now - last;
+        }
+        last = now;
+      },
+      start + x::time::Gap::MilliSeconds(10), x::time::Gap::MilliSeconds(10));
+  r.plan([&r]() { r.stop(); }, start + x::time::Gap::Seconds(1));
+  r.run();
+
+  printf("first %c, normal %d, bulk %d, heartbeat max gap %lums\n", first,
+         normal, bulk, static_cast<unsigned long>(max_gap));
+
+  r.del(normal_fd);
+  r.del(bulk_fd);
+  close(normal_fd);
+  close(bulk_fd);
+  log_finish();
+  return first == 'N' && normal > 0 && bulk > 0 && max_gap < 50 ? 0 : 1;
+}
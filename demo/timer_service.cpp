@@ -0,0 +1,43 @@
+#include "../log/log.h"
+#include "../reactor/timer.h"
+#include <cstdio>
+
+// 同一轮到期的定时器，前面的回调取消了后面的，后面的不应再执行
+// 取消的定时器立即回收，反复 plan/cancel 不会让slot一直增长
+
+int main() {
+  log_init("timer_service");
+
+  x::Eventloop::Reactor r(20, x::time::Gap::Seconds(1));
+  x::Eventloop::TimerService ts(r, 1);
+
+  auto due = x::time::Stamp::Now() + x::time::Gap::MilliSeconds(20);
+  int fired = 0;
+  x::Eventloop::Timer a, b;
+  a = ts.plan([&]() { fired++, ts.cancel(b); }, due);
+  b = ts.plan([&]() { fired++, ts.cancel(a); }, due);
+
+  r.plan([&r]() { r.stop(); },
+         x::time::Stamp::Now() + x::time::Gap::MilliSeconds(100));
+  r.run();
+  printf("2 timers due together, each cancelling the other: %d fired\n",
+         fired);
+
+  const uint32_t N = 10000;
+  auto later = x::time::Stamp::Now() + x::time::Gap::Seconds(3600);
+  uint32_t max_slot = 0;
+  for (int round = 0; round < 10; round++) {
+    std::vector<x::Eventloop::Timer> v;
+    for (uint32_t i = 0; i < N; i++) {
+      v.push_back(ts.plan([]() {}, later));
+      max_slot = std::max(max_slot, v.back().slot);
+    }
+    for (const auto &t : v) {
+      ts.cancel(t);
+    }
+  }
+  printf("10 rounds of %u plan/cancel: highest slot %u\n", N, max_slot);
+
+  log_finish();
+  return fired == 1 && max_slot < N ? 0 : 1;
+}
@@ -0,0 +1,46 @@
+#include "../log/log.h"
+#include "../reactor/reactor.h"
+#include <cstdio>
+#include <set>
+
+// 同一个 slack 窗口内到期的定时器应在同一次唤醒中触发
+// 虚拟时间下每次唤醒时钟只跳一次，触发时刻相同即为同一次唤醒
+
+static size_t wakeups(const x::time::Gap &slack) {
+  auto start = x::time::Stamp::When(2030, 1, 1);
+  x::time::VirtualClock::Enable(start);
+
+  std::set<uint64_t> fired_at;
+  std::vector<x::Eventloop::TimePlan> plans;
+  for (int i = 1; i <= 5; i++) {
+    plans.push_back({[&fired_at]() {
+                       fired_at.insert(
+                           x::time::Stamp::Now().MilliSecondsSinceEpoch());
+                     },
+                     start + x::time::Gap::MilliSeconds(10 * i),
+                     x::time::Gap::InValid(), slack});
+  }
+
+  x::Eventloop::Reactor r(20, x::time::Gap::Seconds(1),
+                          x::time::Gap::InValid(), true);
+  r.plan_many(plans);
+  r.plan([&r]() { r.stop(); }, start + x::time::Gap::Seconds(1));
+  r.run();
+
+  x::time::VirtualClock::Disable();
+  return fired_at.size();
+}
+
+int main() {
+  log_init("timer_slack");
+
+  // 10ms..50ms 五个定时器，slack 50ms 时最早的最晚触发时间是 60ms，全部已到期
+  auto exact = wakeups(x::time::Gap::InValid());
+  auto coalesced = wakeups(x::time::Gap::MilliSeconds(50));
+  printf("5 timers within 50ms: %zu wakeups without slack, %zu with 50ms "
+         "slack\n",
+         exact, coalesced);
+
+  log_finish();
+  return exact == 5 && coalesced == 1 ? 0 : 1;
+}
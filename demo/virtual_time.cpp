@@ -0,0 +1,35 @@
+#include "../log/log.h"
+#include "../reactor/reactor.h"
+#include <chrono>
+#include <cstdio>
+
+// 虚拟时间下跑完一天的分钟级定时器，应在毫秒级完成
+
+int main() {
+  log_init("virtual_time");
+  auto start = x::time::Stamp::When(2030, 1, 1);
+  x::time::VirtualClock::Enable(start);
+
+  int minutes = 0;
+  {
+    x::Eventloop::Reactor r(20, x::time::Gap::Seconds(1),
+                            x::time::Gap::InValid(), true);
+    r.plan([&minutes]() { minutes++; }, start + x::time::Gap::Minutes(1),
+           x::time::Gap::Minutes(1));
+    r.plan([&r]() { r.stop(); }, start + x::time::Gap::Days(1));
+
+    auto begin = std::chrono::steady_clock::now();
+    r.run();
+    std::chrono::duration<double, std::milli> cost =
+        std::chrono::steady_clock::now() - begin;
+    printf("fired %d minute timers in %.1fms, now %s\n", minutes, cost.count(),
+           x::time::Stamp::Now().View().toString().c_str());
+  }
+
+  bool ok = minutes == 24 * 60 &&
+            x::time::Stamp::Now().MilliSecondsSinceEpoch() ==
+                (start + x::time::Gap::Days(1)).MilliSecondsSinceEpoch();
+  x::time::VirtualClock::Disable();
+  log_finish();
+  return ok ? 0 : 1;
+}
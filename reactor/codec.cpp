@@ -0,0 +1,274 @@
+#include "codec.h"
+#include "../log/log.h"
+#include <climits>
+
+x::Eventloop::Codec::Codec(size_t max_frame) : Max_Frame(max_frame) {}
+
+x::Eventloop::Codec::~Codec() {}
+
+void x::Eventloop::Codec::reset() {}
+
+size_t x::Eventloop::Codec::decode_all(std::string_view in,
+                                       std::vector<std::string_view> &frames,
+                                       Decode &status) {
+  size_t total = 0;
+  while (true) {
+    std::string_view frame;
+    size_t consumed = 0;
+    status = decode(in.substr(total), frame, consumed);
+    if (status != Decode::Ok) {
+      return total;
+    }
+    frames.push_back(frame);
+    total += consumed;
+  }
+}
+
+x::Eventloop::LengthCodec::LengthCodec(uint8_t width, size_t max_frame)
+    : Codec(max_frame), Width(width) {
+  if (!(width == 1 || width == 2 || width == 4 || width == 8)) {
+    LOG(FATAL) << "not valid length width: " << static_cast<int>(width);
+  }
+  if (width < 8 && max_frame >= (1ULL << (8 * width))) {
+    LOG(FATAL) << "max frame " << max_frame << " does not fit in "
+               << static_cast<int>(width) << " length bytes";
+  }
+}
+
+x::Eventloop::Decode
+x::Eventloop::LengthCodec::decode(std::string_view in, std::string_view &frame,
+                                  size_t &consumed) {
+  if (in.size() < Width) {
+    return Decode::NeedMore;
+  }
+
+  uint64_t len = 0;
+  for (uint8_t i = 0; i < Width; i++) {
+    len = (len << 8) | static_cast<uint8_t>(in[i]);
+  }
+  if (len > Max_Frame) {
+    return Decode::TooLarge;
+  }
+  if (in.size() - Width < len) {
+    return Decode::NeedMore;
+  }
+
+  frame = in.substr(Width, len);
+  consumed = Width + len;
+  return Decode::Ok;
+}
+
+void x::Eventloop::LengthCodec::encode(std::string_view payload,
+                                       Encoded &e) const {
+  if (payload.size() > Max_Frame) {
+    LOG(FATAL) << "frame too large: " << payload.size();
+  }
+
+  uint64_t len = payload.size();
+  for (int i = Width - 1; i >= 0; i--) {
+    e.head[i] = static_cast<char>(len & 0xff);
+    len >>= 8;
+  }
+  e.iov[0] = {e.head, Width};
+  e.iov[1] = {const_cast<char *>(payload.data()), payload.size()};
+  e.iovcnt = 2;
+}
+
+x::Eventloop::VarintCodec::VarintCodec(size_t max_frame) : Codec(max_frame) {}
+
+x::Eventloop::Decode
+x::Eventloop::VarintCodec::decode(std::string_view in, std::string_view &frame,
+                                  size_t &consumed) {
+  uint64_t len = 0;
+  size_t i = 0;
+  for (;; i++) {
+    if (i == in.size()) {
+      return Decode::NeedMore;
+    }
+    auto b = static_cast<uint8_t>(in[i]);
+    // 第10个字节只剩最高1位可用，且不能再有后续字节
+    if (i == 9 && b > 1) {
+      return Decode::Malformed;
+    }
+    len |= static_cast<uint64_t>(b & 0x7f) << (7 * i);
+    if (len > Max_Frame) {
+      return Decode::TooLarge;
+    }
+    if (!(b & 0x80)) {
+      break;
+    }
+  }
+  i++; // 跳过最后一个字节
+
+  if (in.size() - i < len) {
+    return Decode::NeedMore;
+  }
+
+  frame = in.substr(i, len);
+  consumed = i + len;
+  return Decode::Ok;
+}
+
+void x::Eventloop::VarintCodec::encode(std::string_view payload,
+                                       Encoded &e) const {
+  if (payload.size() > Max_Frame) {
+    LOG(FATAL) << "frame too large: " << payload.size();
+  }
+
+  uint64_t len = payload.size();
+  size_t n = 0;
+  do {
+    uint8_t b = len & 0x7f;
+    len >>= 7;
+    e.head[n++] = static_cast<char>(len ? (b | 0x80) : b);
+  } while (len);
+
+  e.iov[0] = {e.head, n};
+  e.iov[1] = {const_cast<char *>(payload.data()), payload.size()};
+  e.iovcnt = 2;
+}
+
+x::Eventloop::DelimiterCodec::DelimiterCodec(char delimiter, size_t max_frame)
+    : Codec(max_frame), Delimiter(delimiter), scanned_(0) {}
+
+x::Eventloop::Decode
+x::Eventloop::DelimiterCodec::decode(std::string_view in,
+                                     std::string_view &frame,
+                                     size_t &consumed) {
+  if (scanned_ > in.size()) {
+    LOG(FATAL) << "input shrank from " << scanned_ << " to " << in.size()
+               << " bytes without reset()";
+  }
+
+  // glibc 的 memchr 已是向量化实现
+  auto p = static_cast<const char *>(
+      memchr(in.data() + scanned_, Delimiter, in.size() - scanned_));
+  if (p == nullptr) {
+    scanned_ = in.size();
+    return in.size() > Max_Frame ? Decode::TooLarge : Decode::NeedMore;
+  }
+
+  size_t len = p - in.data();
+  scanned_ = 0;
+  if (len > Max_Frame) {
+    return Decode::TooLarge;
+  }
+
+  frame = in.substr(0, len);
+  consumed = len + 1;
+  return Decode::Ok;
+}
+
+void x::Eventloop::DelimiterCodec::encode(std::string_view payload,
+                                          Encoded &e) const {
+  if (payload.size() > Max_Frame) {
+    LOG(FATAL) << "frame too large: " << payload.size();
+  }
+
+  e.head[0] = Delimiter;
+  e.iov[0] = {const_cast<char *>(payload.data()), payload.size()};
+  e.iov[1] = {e.head, 1};
+  e.iovcnt = 2;
+}
+
+void x::Eventloop::DelimiterCodec::reset() { scanned_ = 0; }
+
+x::Eventloop::FixedCodec::FixedCodec(size_t size) : Codec(size) {
+  if (size == 0) {
+    LOG(FATAL) << "not valid fixed frame size: 0";
+  }
+}
+
+x::Eventloop::Decode
+x::Eventloop::FixedCodec::decode(std::string_view in, std::string_view &frame,
+                                 size_t &consumed) {
+  if (in.size() < Max_Frame) {
+    return Decode::NeedMore;
+  }
+  frame = in.substr(0, Max_Frame);
+  consumed = Max_Frame;
+  return Decode::Ok;
+}
+
+void x::Eventloop::FixedCodec::encode(std::string_view payload,
+                                      Encoded &e) const {
+  if (payload.size() != Max_Frame) {
+    LOG(FATAL) << "fixed frame size mismatch: " << payload.size();
+  }
+
+  e.iov[0] = {const_cast<char *>(payload.data()), payload.size()};
+  e.iovcnt = 1;
+}
+
+x::Eventloop::FrameWriter::FrameWriter(const Codec &c)
+    : codec_(c), offset_(0) {}
+
+void x::Eventloop::FrameWriter::push(std::string_view payload) {
+  frames_.emplace_back();
+  codec_.encode(payload, frames_.back());
+}
+
+size_t x::Eventloop::FrameWriter::pending() const { return frames_.size(); }
+
+ssize_t x::Eventloop::FrameWriter::write(Fd f) {
+  ssize_t done = 0;
+  std::vector<struct iovec> iov;
+
+  while (!frames_.empty()) {
+    // 超出 IOV_MAX 的部分留到下一次 writev
+    iov.clear();
+    auto skip = offset_;
+    for (auto i = frames_.begin(); i != frames_.end(); i++) {
+      if (iov.size() + i->iovcnt > IOV_MAX) {
+        break;
+      }
+      for (int j = 0; j < i->iovcnt; j++) {
+        auto v = i->iov[j];
+        if (skip >= v.iov_len) {
+          skip -= v.iov_len;
+          continue;
+        }
+        iov.push_back({static_cast<char *>(v.iov_base) + skip,
+                       v.iov_len - skip});
+        skip = 0;
+      }
+    }
+
+    size_t want = 0;
+    for (const auto &v : iov) {
+      want += v.iov_len;
+    }
+
+    auto ret = writev(f, iov.data(), iov.size());
+    if (ret == -1) {
+      if (errno == EINTR) {
+        continue;
+      }
+      if (errno == EAGAIN || errno == EWOULDBLOCK) {
+        break;
+      }
+      return -1;
+    }
+
+    // 按帧推进，只有整帧写出才出队
+    offset_ += ret;
+    while (!frames_.empty()) {
+      size_t size = 0;
+      const auto &e = frames_.front();
+      for (int j = 0; j < e.iovcnt; j++) {
+        size += e.iov[j].iov_len;
+      }
+      if (offset_ < size) {
+        break;
+      }
+      offset_ -= size;
+      frames_.pop_front();
+      done++;
+    }
+
+    if (static_cast<size_t>(ret) < want) {
+      break; // 内核缓冲已满
+    }
+  }
+  return done;
+}
@@ -0,0 +1,123 @@
+#pragma once
+#include "reactor.h"
+#include <deque>
+#include <string_view>
+#include <sys/types.h>
+#include <sys/uio.h>
+#include <vector>
+
+namespace x {
+namespace Eventloop {
+
+// 分帧编解码，用于 FdChannel/TcpChannel 的读写回调
+// 解码: 直接在读缓冲上切片，返回的 frame 指向输入内存，不拷贝，
+//       输入缓冲被消费或改写后 frame 失效
+// 编码: 头部/分隔符与负载分别作为 iovec，经 writev 发送，不拼接
+
+enum class Decode : uint8_t {
+  Ok,        // 得到一帧
+  NeedMore,  // 数据不足
+  TooLarge,  // 超过 max_frame，调用方应断开连接
+  Malformed, // 帧头非法
+};
+
+class Encoded {
+public:
+  Encoded() = default;
+  Encoded(const Encoded &) = delete; // iov 指向 head，不可拷贝
+  Encoded &operator=(const Encoded &) = delete;
+
+  char head[10];
+  struct iovec iov[2];
+  int iovcnt = 0;
+};
+
+class Codec {
+public:
+  Codec(size_t max_frame);
+  virtual ~Codec();
+
+  // consumed: Ok 时为本帧在输入中占用的字节数(含帧头/分隔符)
+  virtual Decode decode(std::string_view in, std::string_view &frame,
+                        size_t &consumed) = 0;
+  virtual void encode(std::string_view payload, Encoded &) const = 0;
+  virtual void reset();
+
+  // 尽可能多地解出帧，返回共消费的字节数，status 为最后一次 decode 结果
+  size_t decode_all(std::string_view in, std::vector<std::string_view> &frames,
+                    Decode &status);
+
+  const size_t Max_Frame;
+};
+
+// 定长大端长度前缀，width 取 1/2/4/8
+class LengthCodec : public Codec {
+public:
+  LengthCodec(uint8_t width, size_t max_frame);
+  virtual Decode decode(std::string_view, std::string_view &,
+                        size_t &) override;
+  virtual void encode(std::string_view, Encoded &) const override;
+
+  const uint8_t Width;
+};
+
+// LEB128 varint 长度前缀
+class VarintCodec : public Codec {
+public:
+  VarintCodec(size_t max_frame);
+  virtual Decode decode(std::string_view, std::string_view &,
+                        size_t &) override;
+  virtual void encode(std::string_view, Encoded &) const override;
+};
+
+// 分隔符结尾，frame 不含分隔符
+// 数据不足时记住已扫描的位置，下次 decode 须传入同一起点的(更长的)输入，
+// 即上次 decode_all 消费之后的剩余数据加上新读到的数据
+// 换用其他输入(如连接重置、丢弃缓冲)前必须调用 reset()，否则会漏掉分隔符，
+// 输入比上次扫描过的还短时直接 FATAL
+class DelimiterCodec : public Codec {
+public:
+  DelimiterCodec(char delimiter, size_t max_frame);
+  virtual Decode decode(std::string_view, std::string_view &,
+                        size_t &) override;
+  virtual void encode(std::string_view, Encoded &) const override;
+  virtual void reset() override;
+
+  const char Delimiter;
+
+protected:
+  size_t scanned_;
+};
+
+// 定长帧
+class FixedCodec : public Codec {
+public:
+  FixedCodec(size_t size);
+  virtual Decode decode(std::string_view, std::string_view &,
+                        size_t &) override;
+  virtual void encode(std::string_view, Encoded &) const override;
+};
+
+// 多帧合并为一次 writev 发送，部分写时记住进度，下次 write 从断点继续
+// 帧负载不拷贝，用户保证在完整写出前有效
+class FrameWriter {
+public:
+  FrameWriter(const FrameWriter &) = delete;
+  FrameWriter &operator=(const FrameWriter &) = delete;
+
+  FrameWriter(const Codec &);
+
+  void push(std::string_view payload);
+  // 返回本次完整写出的帧数，写满(EAGAIN)时提前返回
+  // 出错返回 -1，errno 有效，未写完的帧仍保留
+  ssize_t write(Fd);
+  size_t pending() const; // 尚未完整写出的帧数(含写了一部分的)
+
+protected:
+  const Codec &codec_;
+  std::deque<Encoded> frames_; // deque 追加不移动元素，iov 指向的 head 保持有效
+  size_t offset_; // frames_.front() 已写出的字节数
+};
+
+}; // namespace Eventloop
+}; // namespace x
@@ -0,0 +1,173 @@
+#include "file.h"
+#include "../log/log.h"
+#include <fcntl.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+static ssize_t do_request(const x::Eventloop::FileRequest &r) {
+  ssize_t ret = 0;
+  do {
+    switch (r.op) {
+    case x::Eventloop::FileOp::Read:
+      ret = pread(r.fd, r.buf, r.len, r.offset);
+      break;
+    case x::Eventloop::FileOp::Write:
+      ret = pwrite(r.fd, r.buf, r.len, r.offset);
+      break;
+    case x::Eventloop::FileOp::Fsync:
+      ret = ::fsync(r.fd);
+      break;
+    case x::Eventloop::FileOp::ReadAhead:
+      ret = ::readahead(r.fd, r.offset, r.len);
+      break;
+    }
+  } while (ret == -1 && errno == EINTR);
+
+  return ret == -1 ? -errno : ret;
+}
+
+x::Eventloop::FileIO::FileIO(Reactor &r, uint8_t threads)
+    : reactor_(r), event_fd(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)),
+      Threads(threads), stopping_(false) {
+  if (event_fd == -1) {
+    LOG(FATAL) << "Failed to create eventfd: " << strerror(errno);
+  }
+  if (threads == 0) {
+    LOG(FATAL) << "FileIO needs at least one thread";
+  }
+
+  reactor_.add(event_fd, Read, [this]() { complete(); });
+
+  for (uint8_t i = 0; i < Threads; i++) {
+    workers_.emplace_back(&FileIO::work, this);
+  }
+  LOG(INFO) << "FileIO created with threads: " << static_cast<int>(Threads);
+}
+
+x::Eventloop::FileIO::~FileIO() {
+  {
+    std::lock_guard<std::mutex> a(mutex_);
+    stopping_ = true;
+  }
+  cv_.notify_all();
+  for (auto &t : workers_) {
+    t.join();
+  }
+
+  reactor_.del(event_fd);
+
+  // 线程退出前已做完的请求还没来得及经 eventfd 分发，在这里补上
+  complete();
+  close(event_fd);
+  LOG(INFO) << "FileIO destroyed";
+}
+
+void x::Eventloop::FileIO::read_at(Fd f, void *buf, size_t len, off_t off,
+                                   const Done &d) {
+  std::vector<FileRequest> v;
+  v.push_back({FileOp::Read, f, buf, len, off, d});
+  submit(std::move(v));
+}
+
+void x::Eventloop::FileIO::write_at(Fd f, const void *buf, size_t len,
+                                    off_t off, const Done &d) {
+  std::vector<FileRequest> v;
+  v.push_back({FileOp::Write, f, const_cast<void *>(buf), len, off, d});
+  submit(std::move(v));
+}
+
+void x::Eventloop::FileIO::fsync(Fd f, const Done &d) {
+  std::vector<FileRequest> v;
+  v.push_back({FileOp::Fsync, f, nullptr, 0, 0, d});
+  submit(std::move(v));
+}
+
+void x::Eventloop::FileIO::readahead(Fd f, off_t off, size_t len) {
+  // readahead(2) 可能阻塞，交给后台线程
+  std::vector<FileRequest> v;
+  v.push_back({FileOp::ReadAhead, f, nullptr, len, off, nullptr});
+  submit(std::move(v));
+}
+
+void x::Eventloop::FileIO::submit(std::vector<FileRequest> &&v) {
+  if (v.empty()) {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> a(mutex_);
+    for (auto &r : v) {
+      pending_.push_back(std::move(r));
+    }
+  }
+  if (v.size() == 1) {
+    cv_.notify_one();
+  } else {
+    cv_.notify_all();
+  }
+}
+
+void x::Eventloop::FileIO::work() {
+  std::vector<FileRequest> batch;
+  std::vector<std::pair<Done, ssize_t>> results;
+
+  while (true) {
+    {
+      std::unique_lock<std::mutex> a(mutex_);
+      cv_.wait(a, [this]() { return stopping_ || !pending_.empty(); });
+      if (pending_.empty()) {
+        return; // stopping_ 且无剩余请求
+      }
+
+      // 每个线程一次取走一部分，剩下的留给其他线程
+      auto n = pending_.size() / Threads + 1;
+      while (n-- && !pending_.empty()) {
+        batch.push_back(std::move(pending_.front()));
+        pending_.pop_front();
+      }
+    }
+
+    for (const auto &r : batch) {
+      auto ret = do_request(r);
+      if (r.done) {
+        results.emplace_back(r.done, ret);
+      }
+    }
+    batch.clear();
+
+    if (results.empty()) {
+      continue;
+    }
+
+    bool notify;
+    {
+      std::lock_guard<std::mutex> a(done_mutex_);
+      notify = done_.empty(); // 已有未处理的完成项时 eventfd 必然已被写过
+      for (auto &r : results) {
+        done_.push_back(std::move(r));
+      }
+    }
+    results.clear();
+
+    if (notify) {
+      uint64_t one = 1;
+      if (write(event_fd, &one, sizeof(one)) == -1 && errno != EAGAIN) {
+        LOG(FATAL) << "Failed to write eventfd: " << strerror(errno);
+      }
+    }
+  }
+}
+
+void x::Eventloop::FileIO::complete() {
+  uint64_t count;
+  read(event_fd, &count, sizeof(count));
+
+  std::vector<std::pair<Done, ssize_t>> done;
+  {
+    std::lock_guard<std::mutex> a(done_mutex_);
+    done.swap(done_);
+  }
+
+  for (const auto &[d, ret] : done) {
+    d(ret);
+  }
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include "reactor.h"
+#include <condition_variable>
+#include <deque>
+#include <sys/types.h>
+#include <thread>
+#include <vector>
+
+namespace x {
+namespace Eventloop {
+
+// 普通文件在epoll中永远可读可写，不能交给Reactor::add
+// FileIO 把磁盘读写丢给后台线程池，完成后经 eventfd 通知 Reactor，
+// 回调总是在 Reactor 所在线程执行，不会阻塞事件循环
+
+// >=0 : 读写的字节数(fsync为0) ; <0 : -errno
+using Done = std::function<void(ssize_t)>;
+
+enum class FileOp : uint8_t { Read, Write, Fsync, ReadAhead };
+
+class FileRequest {
+public:
+  FileOp op;
+  Fd fd;
+  void *buf;   // Read/Write 时使用，用户保证在回调前有效
+  size_t len;  // Read/Write/ReadAhead 时使用
+  off_t offset;
+  Done done;   // 可以为空
+};
+
+class FileIO {
+public:
+  FileIO(const FileIO &) = delete;
+  FileIO &operator=(const FileIO &) = delete;
+
+  // Owner thread call only
+  FileIO(Reactor &, uint8_t threads = 2);
+  ~FileIO(); // 阻塞到已提交的请求全部完成，并在此执行剩余的回调
+
+  // any thread
+  void read_at(Fd, void *, size_t, off_t, const Done &);
+  void write_at(Fd, const void *, size_t, off_t, const Done &);
+  void fsync(Fd, const Done &);
+  void readahead(Fd, off_t, size_t); // 预读提示，无回调
+  void submit(std::vector<FileRequest> &&); // 批量提交，只唤醒一次
+
+protected:
+  void work();
+  void complete();
+
+  Reactor &reactor_;
+  const int event_fd;
+  const uint8_t Threads; // work() 可能在 workers_ 还在构造时运行，不读 workers_
+  bool stopping_;
+  std::vector<std::thread> workers_;
+  std::deque<FileRequest> pending_;
+  std::vector<std::pair<Done, ssize_t>> done_;
+  std::mutex mutex_;
+  std::mutex done_mutex_;
+  std::condition_variable cv_;
+};
+}; // namespace Eventloop
+}; // namespace x
@@ -1,8 +1,12 @@
 #include "reactor.h"
 #include "../log/log.h"
 #include <bits/types/struct_itimerspec.h>
+#include <chrono>
+#include <climits>
 #include <sys/epoll.h>
+#include <sys/socket.h>
 #include <sys/timerfd.h>
+#include <sys/uio.h>
 
 static thread_local x::Eventloop::Reactor *reactor_in_this_thread = nullptr;
 
@@ -19,6 +23,15 @@ static void add_fd_to_epoll(int epoll_fd, int fd, int events) {
     LOG(FATAL) << "Failed to add fd to epoll: " << strerror(errno);
   }
 }
+static void mod_fd_to_epoll(int epoll_fd, int fd, int events) {
+  struct epoll_event ee;
+  ee.events = events;
+  ee.data.fd = fd;
+  auto ret = epoll_ctl(epoll_fd, EPOLL_CTL_MOD, fd, &ee);
+  if (ret == -1) {
+    LOG(FATAL) << "Failed to modify fd in epoll: " << strerror(errno);
+  }
+}
 static void del_fd_to_epoll(int epoll_fd, int fd) {
   auto ret = epoll_ctl(epoll_fd, EPOLL_CTL_DEL, fd, nullptr);
   if (ret == -1) {
@@ -26,19 +39,14 @@ static void del_fd_to_epoll(int epoll_fd, int fd) {
   }
 }
 
-static int create_timefd(const x::time::Stamp &s, const x::time::Gap &g) {
-  int time_fd = timerfd_create(CLOCK_REALTIME, 0);
-  if (time_fd == -1) {
-    LOG(FATAL) << "Failed to create timefd: " << strerror(errno);
-  }
+static void set_timefd(int time_fd, uint64_t milliseconds_since_epoch,
+                       uint64_t milliseconds) {
   struct itimerspec tm;
   memset(&tm, 0, sizeof(tm));
 
-  auto milliseconds_since_epoch = s.MilliSecondsSinceEpoch();
   tm.it_value.tv_sec = milliseconds_since_epoch / 1000;
   tm.it_value.tv_nsec = (milliseconds_since_epoch % 1000) * 1000000;
 
-  auto milliseconds = g.MilliSeconds();
   tm.it_interval.tv_sec = milliseconds / 1000;
   tm.it_interval.tv_nsec = (milliseconds % 1000) * 1000000;
 
@@ -46,12 +54,25 @@ static int create_timefd(const x::time::Stamp &s, const x::time::Gap &g) {
   if (ret == -1) {
     LOG(FATAL) << "Failed to set timerfd time: " << strerror(errno);
   }
+}
+
+static int create_timefd(const x::time::Stamp &s, const x::time::Gap &g) {
+  int time_fd = timerfd_create(CLOCK_REALTIME, 0);
+  if (time_fd == -1) {
+    LOG(FATAL) << "Failed to create timefd: " << strerror(errno);
+  }
+  set_timefd(time_fd, s.MilliSecondsSinceEpoch(), g.MilliSeconds());
   return time_fd;
 }
 
-x::Eventloop::Reactor::Reactor(uint16_t m, const Gap &g)
-    : Max_Events(m), Max_Timeout(g), epoll_fd(epoll_create1(0)),
-      running_(false) {
+x::Eventloop::Reactor::Reactor(uint16_t m, const Gap &g, const Gap &budget,
+                               bool virtual_time)
+    : Max_Events(m), Max_Timeout(g), Budget(budget),
+      Virtual_Time(virtual_time), epoll_fd(epoll_create1(0)),
+      timer_fd(virtual_time ? -1
+                            : timerfd_create(CLOCK_REALTIME,
+                                             TFD_NONBLOCK | TFD_CLOEXEC)),
+      enabled_clock_(false), running_(false), next_soft_(-1), armed_(0) {
 
   if (epoll_fd == -1) {
     LOG(FATAL) << "Failed to create epoll file descriptor: " << strerror(errno);
@@ -67,9 +88,22 @@ x::Eventloop::Reactor::Reactor(uint16_t m, const Gap &g)
     LOG(FATAL) << "epoll_ctl failed";
   }
 
+  if (Virtual_Time && !x::time::VirtualClock::isEnabled()) {
+    x::time::VirtualClock::Enable();
+    enabled_clock_ = true;
+  }
+  if (!Virtual_Time) {
+    if (timer_fd == -1) {
+      LOG(FATAL) << "Failed to create timefd: " << strerror(errno);
+    }
+    add_fd_to_epoll(epoll_fd, timer_fd, Read);
+  }
+
   reactor_in_this_thread = this;
   LOG(INFO) << "Reactor created with max events: " << Max_Events
-            << " max timeout: " << Max_Timeout.MilliSeconds() << "ms";
+            << " max timeout: " << Max_Timeout.MilliSeconds() << "ms"
+            << " budget: " << Budget.MilliSeconds() << "ms"
+            << (Virtual_Time ? " virtual time" : "");
 }
 
 x::Eventloop::Reactor::~Reactor() {
@@ -79,16 +113,25 @@ x::Eventloop::Reactor::~Reactor() {
   {
     std::lock_guard<std::mutex> a(mutex_);
     for (const auto &[k, v] : timefd_info_) {
-      close(k);
+      if (k >= 0) {
+        close(k);
+      }
+    }
+    if (timer_fd != -1) {
+      close(timer_fd);
     }
     close(epoll_fd);
     reactor_in_this_thread = nullptr;
   }
+  if (enabled_clock_) {
+    x::time::VirtualClock::Disable();
+  }
 
   LOG(INFO) << "Reactor destroyed";
 }
 
-void x::Eventloop::Reactor::add(Fd f, Event e, const Callable &c) {
+void x::Eventloop::Reactor::add(Fd f, Event e, const Callable &c,
+                                Priority p) {
   if (!isReactorMatchThread(this)) {
     LOG(FATAL) << "Reactor is not matching the thread!";
   }
@@ -97,12 +140,22 @@ void x::Eventloop::Reactor::add(Fd f, Event e, const Callable &c) {
   if (!(e & Read || e & Write || e & Error || e & Timeout || e & Close)) {
     LOG(FATAL) << "not valid event input";
   }
+  if (p >= Lanes) {
+    LOG(FATAL) << "not valid priority input";
+  }
 
-  add_fd_to_epoll(epoll_fd, f, e);
+  // 输出合并因短写已把fd加进epoll关注EPOLLOUT时，只能MOD
+  auto o = output_.find(f);
+  if (o != output_.end() && o->second.watching) {
+    mod_fd_to_epoll(epoll_fd, f, e | EPOLLOUT);
+  } else {
+    add_fd_to_epoll(epoll_fd, f, e);
+  }
 
   {
     std::lock_guard<std::mutex> a(mutex_);
     fd_event_callable_[f][e] = {0, c};
+    fd_priority_[f] = p;
   }
 }
 
@@ -111,12 +164,19 @@ void x::Eventloop::Reactor::del(Fd f) {
     LOG(FATAL) << "Reactor is not matching the thread!";
   }
   LOG(INFO) << "Deleting fd: " << f;
-  del_fd_to_epoll(epoll_fd, f);
+  ready_events_.erase(f);
+  output_.erase(f);
+  immediate_.erase(f);
+  not_socket_.erase(f);
 
   {
     std::lock_guard<std::mutex> a(mutex_);
+    if (!forget_soft(f)) {
+      del_fd_to_epoll(epoll_fd, f);
+    }
     fd_event_callable_.erase(f);
     timefd_info_.erase(f);
+    fd_priority_.erase(f);
   }
 }
 
@@ -126,9 +186,16 @@ void x::Eventloop::Reactor::del(Fd f, Event e) {
   }
   LOG(INFO) << "Deleting event: " << e << " from fd: " << f;
 
-  del_fd_to_epoll(epoll_fd, f);
+  // fd 已整个移出epoll，待写数据改为下轮直接重试
+  auto o = output_.find(f);
+  if (o != output_.end()) {
+    o->second.watching = false;
+  }
 
   std::lock_guard<std::mutex> a(mutex_);
+  if (!forget_soft(f)) {
+    del_fd_to_epoll(epoll_fd, f);
+  }
 
   auto i = fd_event_callable_.find(f);
   if (i != fd_event_callable_.end()) {
@@ -137,6 +204,7 @@ void x::Eventloop::Reactor::del(Fd f, Event e) {
     //失去最后一个event的监视，自动释放对fd的监视
     if (i->second.empty()) {
       fd_event_callable_.erase(i);
+      fd_priority_.erase(f);
     }
   }
   timefd_info_.erase(f);
@@ -146,16 +214,11 @@ x::Eventloop::Event x::Eventloop::Reactor::get(Fd f) const {
   if (!isReactorMatchThread(this)) {
     LOG(FATAL) << "Reactor is not matching the thread!";
   }
-  Event ret = 0;
+  Event ret;
 
   {
     std::lock_guard<std::mutex> a(mutex_);
-    auto i = fd_event_callable_.find(f);
-    if (i != fd_event_callable_.end()) {
-      for (const auto &j : i->second) {
-        ret |= j.first;
-      }
-    }
+    ret = registered(f);
   }
   LOG(INFO) << "Getting event: " << ret << " from fd: " << f;
   return ret;
@@ -188,74 +251,255 @@ void x::Eventloop::Reactor::run() {
   std::vector<struct epoll_event> events(Max_Events);
 
   while (running_) {
+    // 上一轮有未分发完的事件时不阻塞
+    bool busy = !ready_events_.empty();
+    if (Virtual_Time) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      busy |= !soft_due_.empty();
+    }
     int nfd = epoll_wait(epoll_fd, events.data(), Max_Events,
-                         Max_Timeout.MilliSeconds());
+                         busy ? 0 : Max_Timeout.MilliSeconds());
 
     if (nfd == -1) {
+      if (errno == EINTR) {
+        continue;
+      }
       LOG(FATAL) << "epoll_wait failed: " << strerror(errno);
     }
 
-    for (int i = 0; i < nfd; i++) {
-      auto fd = events[i].data.fd;
-      if (events[i].events & (Read | Write | Error | Timeout | Close)) {
-        std::lock_guard<std::mutex> lock(mutex_);
-        auto &fd_map = fd_event_callable_[fd];
-
-        if (events[i].events & Read) {
-          if (fd_map.count(Read)) {
-            LOG(INFO) << "fd:" << fd << " trrigger read event";
-            auto &[iteration, callable] = fd_map[Read];
-            iteration++;
-            callable();
-          }
-
-          // timefd超时后要read一下
-          if (timefd_info_.count(fd)) {
-            uint64_t expirations;
-            read(fd, &expirations, sizeof(expirations));
-          }
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      for (int i = 0; i < nfd; i++) {
+        if (events[i].data.fd == timer_fd) {
+          uint64_t expirations;
+          read(timer_fd, &expirations, sizeof(expirations));
+          armed_ = 0;
+          continue;
         }
-        if (events[i].events & Write) {
-          if (fd_map.count(Write)) {
-            LOG(INFO) << "fd:" << fd << " trrigger write event";
-            auto &[iteration, callable] = fd_map[Write];
-            iteration++;
-            callable();
+        auto fd = events[i].data.fd;
+        uint32_t e = events[i].events;
+
+        auto o = output_.find(fd);
+        if (o != output_.end() && o->second.watching && (e & EPOLLOUT)) {
+          o->second.writable = true;
+          // EPOLLOUT 是为输出合并关注的，用户没注册时不分发
+          if (!(registered(fd) & EPOLLOUT)) {
+            e &= ~EPOLLOUT;
           }
-        }
-        if (events[i].events & Error) {
-          if (fd_map.count(Error)) {
-            LOG(INFO) << "fd:" << fd << " trrigger error event";
-            auto &[iteration, callable] = fd_map[Error];
-            iteration++;
-            callable();
+          if (!e) {
+            continue;
           }
         }
-        if (events[i].events & Timeout) {
-          if (fd_map.count(Timeout)) {
-            LOG(INFO) << "fd:" << fd << " trrigger timeout event";
-            auto &[iteration, callable] = fd_map[Timeout];
-            iteration++;
-            callable();
-          }
+        ready(fd, e);
+      }
+
+      // 没有真实事件时，虚拟时钟直接跳到最早的最晚触发时间
+      if (Virtual_Time && !expire() && ready_events_.empty() &&
+          !soft_deadline_.empty()) {
+        x::time::VirtualClock::Set(soft_deadline_.begin()->first);
+        expire();
+      }
+      if (!Virtual_Time) {
+        expire();
+        rearm();
+      }
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    auto over_budget = [this, &start]() {
+      return Budget.isValid() &&
+             std::chrono::steady_clock::now() - start >=
+                 std::chrono::milliseconds(Budget.MilliSeconds());
+    };
+
+    for (Priority p = Urgent; p < Lanes && running_; p++) {
+      // 预算用完后每个lane本轮仍至少分发一个，顺延的fd排在lane前面，
+      // 低优先级不会被持续的高优先级流量饿死
+      auto &lane = ready_[p];
+      bool served = false;
+      while (!lane.empty() && running_) {
+        if (p != Urgent && served && over_budget()) {
+          break;
         }
-        if (events[i].events & Close) {
-          if (fd_map.count(Close)) {
-            LOG(INFO) << "fd:" << fd << " trrigger close event";
-            auto &[iteration, callable] = fd_map[Close];
-            iteration++;
-            callable();
-          }
+        auto fd = lane.front();
+        lane.pop_front();
+
+        auto i = ready_events_.find(fd);
+        if (i == ready_events_.end()) {
+          continue; // 分发前已被del
         }
+        auto e = i->second;
+        ready_events_.erase(i);
+        dispatch(fd, e);
+        served = true;
       }
     }
+
+    flush_all();
   }
 
   LOG(INFO) << "Reactor is not running";
 }
 
+// 需持有mutex_，f是不占用fd的定时器时返回true(它不在epoll中)
+bool x::Eventloop::Reactor::forget_soft(Fd f) {
+  if (f >= 0) {
+    return false;
+  }
+  auto i = soft_info_.find(f);
+  if (i != soft_info_.end()) {
+    auto [due, slack] = i->second;
+    soft_due_.erase({due, f});
+    soft_deadline_.erase({due + slack, f});
+    soft_info_.erase(i);
+  }
+  return true;
+}
+
+// 需持有mutex_，把到期的定时器加入就绪队列
+bool x::Eventloop::Reactor::expire() {
+  auto now = Stamp::Now().MilliSecondsSinceEpoch();
+  bool any = false;
+
+  while (!soft_due_.empty() && soft_due_.begin()->first <= now) {
+    auto [due, fd] = *soft_due_.begin();
+    auto slack = soft_info_.at(fd).second;
+    soft_due_.erase(soft_due_.begin());
+    soft_deadline_.erase({due + slack, fd});
+    any = true;
+
+    auto interval = timefd_info_.at(fd).second.MilliSeconds();
+    if (interval) {
+      // 与timerfd相同，错过的多次到期只触发一次，按计划时间推进不累积误差
+      due += ((now - due) / interval + 1) * interval;
+      soft_due_.insert({due, fd});
+      soft_deadline_.insert({due + slack, fd});
+      soft_info_[fd] = {due, slack};
+    } else {
+      soft_info_.erase(fd);
+    }
+    ready(fd, Read);
+  }
+  return any;
+}
+
+// 需持有mutex_，timer_fd 只在最早的最晚触发时间唤醒一次
+void x::Eventloop::Reactor::rearm() {
+  if (Virtual_Time) {
+    return;
+  }
+  uint64_t deadline = soft_deadline_.empty() ? 0 : soft_deadline_.begin()->first;
+  if (deadline == armed_) {
+    return;
+  }
+  set_timefd(timer_fd, deadline, 0); // 0 即解除
+  armed_ = deadline;
+}
+
+// 需持有mutex_
+x::Eventloop::Fd x::Eventloop::Reactor::plan_soft(const Callable &c,
+                                                  const Stamp &s, const Gap &g,
+                                                  const Gap &slack) {
+  auto id = next_soft_--;
+  fd_event_callable_[id][Read] = {0, c};
+  timefd_info_[id] = {s, g};
+  fd_priority_[id] = Urgent;
+
+  // 与timerfd相同，InValid 的 Stamp 永不触发
+  if (s.isValid()) {
+    auto due = s.MilliSecondsSinceEpoch();
+    soft_due_.insert({due, id});
+    soft_deadline_.insert({due + slack.MilliSeconds(), id});
+    soft_info_[id] = {due, slack.MilliSeconds()};
+  }
+  return id;
+}
+
+// 需持有mutex_
+x::Eventloop::Event x::Eventloop::Reactor::registered(Fd f) const {
+  Event ret = 0;
+  auto i = fd_event_callable_.find(f);
+  if (i != fd_event_callable_.end()) {
+    for (const auto &j : i->second) {
+      ret |= j.first;
+    }
+  }
+  return ret;
+}
+
+// 需持有mutex_
+void x::Eventloop::Reactor::ready(Fd fd, uint32_t e) {
+  // LT模式下未分发的fd会被再次报告，合并即可
+  auto i = ready_events_.find(fd);
+  if (i != ready_events_.end()) {
+    i->second |= e;
+    return;
+  }
+
+  auto p = fd_priority_.find(fd);
+  ready_events_[fd] = e;
+  ready_[p == fd_priority_.end() ? Normal : p->second].push_back(fd);
+}
+
+void x::Eventloop::Reactor::dispatch(Fd fd, uint32_t e) {
+  if (!(e & (Read | Write | Error | Timeout | Close))) {
+    return;
+  }
+
+  // 回调在锁外执行，回调中可以add/del/plan
+  static constexpr std::pair<uint8_t, const char *> kinds[] = {
+      {Read, "read"},
+      {Write, "write"},
+      {Error, "error"},
+      {Timeout, "timeout"},
+      {Close, "close"}};
+
+  for (const auto &[kind, name] : kinds) {
+    if (!(e & kind)) {
+      continue;
+    }
+
+    Callable callable;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      auto i = fd_event_callable_.find(fd);
+      if (i == fd_event_callable_.end()) {
+        return;
+      }
+
+      // timefd超时后要read一下
+      if (kind == Read && fd >= 0 && timefd_info_.count(fd)) {
+        uint64_t expirations;
+        read(fd, &expirations, sizeof(expirations));
+      }
+
+      auto j = i->second.find(kind);
+      if (j == i->second.end()) {
+        continue;
+      }
+      j->second.first++;
+      callable = j->second.second;
+    }
+
+    LOG(INFO) << "fd:" << fd << " trrigger " << name << " event";
+    callable();
+  }
+}
+
 x::Eventloop::Fd x::Eventloop::Reactor::plan(const Callable &c, const Stamp &s,
-                                             const Gap &g) {
+                                             const Gap &g, const Gap &slack) {
+  if (Virtual_Time || slack.isValid()) {
+    Fd id;
+    {
+      std::lock_guard<std::mutex> a(mutex_);
+      id = plan_soft(c, s, g, slack);
+      rearm();
+    }
+    LOG(INFO) << "Planned new timer event: " << id
+              << " slack: " << slack.MilliSeconds() << "ms";
+    return id;
+  }
+
   auto time_fd = create_timefd(s, g);
   add_fd_to_epoll(epoll_fd, time_fd, Read);
 
@@ -263,20 +507,207 @@ x::Eventloop::Fd x::Eventloop::Reactor::plan(const Callable &c, const Stamp &s,
     std::lock_guard<std::mutex> a(mutex_);
     fd_event_callable_[time_fd][Read] = {0, c};
     timefd_info_[time_fd] = {s, g};
+    fd_priority_[time_fd] = Urgent;
   }
   LOG(INFO) << "Planned new timer event: " << time_fd;
   return time_fd;
 }
 
+std::vector<x::Eventloop::Fd>
+x::Eventloop::Reactor::plan_many(const std::vector<TimePlan> &plans) {
+  std::vector<Fd> ids;
+  ids.reserve(plans.size());
+  {
+    std::lock_guard<std::mutex> a(mutex_);
+    for (const auto &p : plans) {
+      ids.push_back(plan_soft(p.callable, p.when, p.interval, p.slack));
+    }
+    rearm();
+  }
+  LOG(INFO) << "Planned " << ids.size() << " timer events";
+  return ids;
+}
+
 void x::Eventloop::Reactor::cancel(Fd f) {
   std::lock_guard<std::mutex> a(mutex_);
 
-  del_fd_to_epoll(epoll_fd, f);
+  if (!forget_soft(f)) {
+    del_fd_to_epoll(epoll_fd, f);
+  }
   fd_event_callable_.erase(f);
   timefd_info_.erase(f);
+  fd_priority_.erase(f);
   LOG(INFO) << "Cancelled timer event: " << f;
 }
 
+void x::Eventloop::Reactor::send(Fd f, std::string &&data) {
+  if (!isReactorMatchThread(this)) {
+    LOG(FATAL) << "Reactor is not matching the thread!";
+  }
+  if (data.empty()) {
+    return;
+  }
+
+  auto &o = output_[f];
+  o.chunks.push_back(std::move(data));
+  if (immediate_.count(f) && !o.watching) {
+    write_out(f);
+  }
+}
+
+void x::Eventloop::Reactor::send(Fd f, std::string_view data) {
+  if (!isReactorMatchThread(this)) {
+    LOG(FATAL) << "Reactor is not matching the thread!";
+  }
+  if (data.empty()) {
+    return;
+  }
+
+  // 小块直接拼到上一块后面，减少iovec个数
+  auto &o = output_[f];
+  if (!o.chunks.empty() && o.chunks.back().size() + data.size() <= 4096) {
+    o.chunks.back().append(data);
+  } else {
+    o.chunks.emplace_back(data);
+  }
+  if (immediate_.count(f) && !o.watching) {
+    write_out(f);
+  }
+}
+
+void x::Eventloop::Reactor::send(Fd f, const char *data) {
+  send(f, std::string_view(data));
+}
+
+void x::Eventloop::Reactor::flush(Fd f) {
+  if (!isReactorMatchThread(this)) {
+    LOG(FATAL) << "Reactor is not matching the thread!";
+  }
+  if (output_.count(f)) {
+    write_out(f);
+  }
+}
+
+void x::Eventloop::Reactor::immediate(Fd f, bool on) {
+  if (!isReactorMatchThread(this)) {
+    LOG(FATAL) << "Reactor is not matching the thread!";
+  }
+  LOG(INFO) << "Set fd: " << f << " immediate output: " << on;
+  if (on) {
+    immediate_.insert(f);
+    flush(f);
+  } else {
+    immediate_.erase(f);
+  }
+}
+
+bool x::Eventloop::Reactor::write_out(Fd f) {
+  auto &o = output_.at(f);
+
+  while (!o.chunks.empty()) {
+    struct iovec iov[64];
+    int n = 0;
+    for (auto i = o.chunks.begin(); i != o.chunks.end() && n < 64; i++, n++) {
+      auto skip = n == 0 ? o.offset : 0;
+      iov[n] = {i->data() + skip, i->size() - skip};
+    }
+
+    // 对端已关闭的socket用writev会收到SIGPIPE，socket改用MSG_NOSIGNAL
+    ssize_t ret;
+    if (!not_socket_.count(f)) {
+      struct msghdr msg;
+      memset(&msg, 0, sizeof(msg));
+      msg.msg_iov = iov;
+      msg.msg_iovlen = n;
+      ret = sendmsg(f, &msg, MSG_NOSIGNAL);
+      if (ret == -1 && errno == ENOTSOCK) {
+        not_socket_.insert(f);
+        continue;
+      }
+    } else {
+      ret = writev(f, iov, n);
+    }
+    if (ret == -1) {
+      if (errno == EINTR) {
+        continue;
+      }
+      if (errno == EAGAIN || errno == EWOULDBLOCK) {
+        break;
+      }
+      LOG(WARNING) << "Failed to write fd: " << f << " " << strerror(errno)
+                   << ", dropping pending output";
+      if (o.watching) {
+        watch_output(f, false);
+      }
+      output_.erase(f);
+      return true;
+    }
+
+    size_t left = ret;
+    while (left) {
+      auto remain = o.chunks.front().size() - o.offset;
+      if (left < remain) {
+        o.offset += left;
+        break;
+      }
+      left -= remain;
+      o.offset = 0;
+      o.chunks.pop_front();
+    }
+  }
+
+  if (o.chunks.empty()) {
+    if (o.watching) {
+      watch_output(f, false);
+    }
+    output_.erase(f);
+    return true;
+  }
+
+  if (!o.watching) {
+    watch_output(f, true);
+  }
+  o.writable = false;
+  return false;
+}
+
+void x::Eventloop::Reactor::flush_all() {
+  std::vector<Fd> fds;
+  for (const auto &[f, o] : output_) {
+    if (!o.watching || o.writable) {
+      fds.push_back(f);
+    }
+  }
+  for (auto f : fds) {
+    write_out(f);
+  }
+}
+
+void x::Eventloop::Reactor::watch_output(Fd f, bool on) {
+  Event e;
+  {
+    std::lock_guard<std::mutex> a(mutex_);
+    e = registered(f);
+  }
+
+  if (on) {
+    if (e) {
+      mod_fd_to_epoll(epoll_fd, f, e | EPOLLOUT);
+    } else {
+      add_fd_to_epoll(epoll_fd, f, EPOLLOUT);
+    }
+  } else {
+    if (e) {
+      mod_fd_to_epoll(epoll_fd, f, e);
+    } else {
+      del_fd_to_epoll(epoll_fd, f);
+    }
+  }
+  output_.at(f).watching = on;
+}
+
+bool x::Eventloop::Reactor::isVirtualTime() const { return Virtual_Time; }
+
 void x::Eventloop::Reactor::stop() {
   LOG(INFO) << "Stopping the reactor.";
   running_ = false;
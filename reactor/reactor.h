@@ -1,9 +1,15 @@
 #pragma once
 #include "../time/time.h"
 #include <atomic>
+#include <deque>
 #include <functional>
 #include <mutex>
+#include <set>
+#include <string>
+#include <string_view>
 #include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 namespace x {
 namespace Eventloop {
@@ -22,6 +28,13 @@ constexpr uint8_t Error = 4;
 constexpr uint8_t Timeout = 8;
 constexpr uint8_t Close = 16;
 
+// 优先级，数值越小越先分发
+using Priority = uint8_t;
+constexpr Priority Urgent = 0; // 心跳/控制面，定时器默认在此，不受时间预算限制
+constexpr Priority Normal = 1;
+constexpr Priority Bulk = 2;
+constexpr Priority Lanes = 3;
+
 class EventView {
 public:
   Fd fd;
@@ -41,36 +54,115 @@ public:
         interval(interval) {}
 };
 
+// plan_many 的一项，slack 含义同 Reactor::plan
+class TimePlan {
+public:
+  Callable callable;
+  Stamp when;
+  Gap interval;
+  Gap slack;
+};
+
 class Reactor {
 public:
   Reactor(const Reactor &) = delete;
   Reactor &operator=(const Reactor &) = delete;
 
   // Owner thread call only
-  Reactor(uint16_t m, const Gap &);
+  // budget: 每轮分发 Normal/Bulk 的时间上限，超出部分留到下一轮，InValid为不限
+  //         超出后每个lane本轮仍至少分发一个，保证低优先级持续推进
+  // virtual_time: 定时器改用 time::VirtualClock，空闲时时钟直接跳到下一个到期的
+  //               定时器，真实fd照常分发。虚拟时钟是进程全局的，开启期间所有
+  //               Stamp::Now() 都读虚拟时间；由本Reactor开启的会在析构时关闭
+  Reactor(uint16_t m, const Gap &, const Gap &budget = Gap::InValid(),
+          bool virtual_time = false);
   ~Reactor();
   void run();
-  void add(Fd, Event, const Callable &);
+  void add(Fd, Event, const Callable &, Priority = Normal); // 优先级以fd为单位
   void del(Fd, Event);
   void del(Fd);
   Event get(Fd) const;
   EventView get(Fd, Event) const; // user should make sure event exist
 
+  // 输出合并: 一轮分发中对同一fd的send先排队，本轮结束时一次writev写出
+  // socket 以 MSG_NOSIGNAL 写出，对端关闭时丢弃剩余输出而不会收到SIGPIPE
+  // 写不完的部分等fd可写后继续，del(fd)丢弃未写出的数据
+  void send(Fd, std::string &&);
+  void send(Fd, std::string_view);
+  void send(Fd, const char *); // 字面量，避免上面两者二义
+  void flush(Fd);                   // 立即写出
+  void immediate(Fd, bool = true);  // 对延迟敏感的fd，每次send立即写出
+
   // any thread
   void stop();
+  bool isVirtualTime() const;
   TimeEventView check(Fd);
-  Fd plan(const Callable &, const Stamp &, const Gap & = Gap::InValid());
+  // slack: 允许推迟触发的最大时长，窗口内到期的定时器在同一次唤醒中触发
+  // 带 slack 的定时器及虚拟时间下的定时器不占用fd，返回的句柄为负数
+  Fd plan(const Callable &, const Stamp &, const Gap & = Gap::InValid(),
+          const Gap &slack = Gap::InValid());
+  std::vector<Fd> plan_many(const std::vector<TimePlan> &); // 总是不占用fd
   void cancel(Fd); // delete time fd
 
 protected:
+  void ready(Fd, uint32_t);
+  void dispatch(Fd, uint32_t);
+  Event registered(Fd) const; // 需持有mutex_
+  // 以下需持有mutex_
+  Fd plan_soft(const Callable &, const Stamp &, const Gap &, const Gap &);
+  bool forget_soft(Fd);
+  bool expire();
+  void rearm();
+
+  // 以下只在owner线程调用
+  bool write_out(Fd); // 写完返回true
+  void flush_all();
+  void watch_output(Fd, bool);
+
   const int Max_Events;
   const Gap Max_Timeout;
+  const Gap Budget;
+  const bool Virtual_Time;
   const int epoll_fd;
+  const int timer_fd; // 驱动不占用fd的定时器，虚拟时间下为-1
+  bool enabled_clock_; // VirtualClock 是否由本Reactor开启
   std::atomic<bool> running_;
   std::unordered_map<Fd,
                      std::unordered_map<Event, std::pair<Iteration, Callable>>>
       fd_event_callable_;
   std::unordered_map<Fd, std::pair<Stamp, Gap>> timefd_info_;
+  std::unordered_map<Fd, Priority> fd_priority_;
+
+  // 同一时刻到期时按plan的先后(句柄递减)排序
+  struct SoftOrder {
+    bool operator()(const std::pair<uint64_t, Fd> &a,
+                    const std::pair<uint64_t, Fd> &b) const {
+      return a.first != b.first ? a.first < b.first : a.second > b.second;
+    }
+  };
+
+  // 不占用fd的定时器: 按到期时间排序，按最晚触发时间(到期+slack)决定唤醒
+  std::set<std::pair<uint64_t, Fd>, SoftOrder> soft_due_;
+  std::set<std::pair<uint64_t, Fd>, SoftOrder> soft_deadline_;
+  std::unordered_map<Fd, std::pair<uint64_t, uint64_t>> soft_info_; // due,slack
+  Fd next_soft_;
+  uint64_t armed_;
+
+  // 待写出的数据，只在owner线程访问
+  class Output {
+  public:
+    std::deque<std::string> chunks;
+    size_t offset = 0; // chunks.front() 已写出的字节数
+    bool watching = false; // 已在epoll中关注EPOLLOUT
+    bool writable = false;
+  };
+  std::unordered_map<Fd, Output> output_;
+  std::unordered_set<Fd> immediate_;
+  std::unordered_set<Fd> not_socket_; // sendmsg 返回过 ENOTSOCK 的fd
+
+  // 就绪但尚未分发的fd，只在owner线程访问
+  std::deque<Fd> ready_[Lanes];
+  std::unordered_map<Fd, uint32_t> ready_events_;
   mutable std::mutex mutex_;
 };
 }; // namespace Eventloop
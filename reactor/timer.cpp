@@ -0,0 +1,283 @@
+#include "timer.h"
+#include "../log/log.h"
+#include <algorithm>
+#include <sys/timerfd.h>
+
+static constexpr uint64_t Disarmed = UINT64_MAX;
+
+// 线程首次使用时分配，之后固定落在同一个分片
+static std::atomic<uint32_t> next_thread_hint{0};
+static thread_local uint32_t thread_hint = next_thread_hint++;
+
+static constexpr uint32_t NoIndex = UINT32_MAX;
+
+// 仅本文件使用，放在匿名命名空间中避免与其他翻译单元的同名类冲突
+namespace {
+class Slot {
+public:
+  x::Eventloop::Callable callable;
+  uint64_t due;
+  uint64_t interval;
+  uint32_t generation;
+  uint32_t index; // 在堆中的下标，不在堆中为 NoIndex
+  bool live;
+};
+}; // namespace
+
+// 对齐到缓存行，避免不同生产者之间伪共享
+class alignas(64) x::Eventloop::TimerService::Shard {
+public:
+  std::mutex mutex;
+  std::vector<uint32_t> heap; // 按 due 的小顶堆，元素为slot下标
+  std::vector<Slot> slots;
+  std::vector<uint32_t> free;
+  std::atomic<uint64_t> earliest{Disarmed};
+
+  // 以下需持有mutex
+  // 每个slot记住自己在堆中的位置，cancel 时可直接删除而不必等到期
+  void push(uint32_t s) {
+    slots[s].index = heap.size();
+    heap.push_back(s);
+    up(heap.size() - 1);
+  }
+
+  void erase(uint32_t i) {
+    slots[heap[i]].index = NoIndex;
+    if (i + 1 != heap.size()) {
+      place(i, heap.back());
+      heap.pop_back();
+      up(i);
+      down(i);
+    } else {
+      heap.pop_back();
+    }
+  }
+
+  void update() {
+    earliest = heap.empty() ? Disarmed : slots[heap.front()].due;
+  }
+
+  // 回收已不会再触发的slot，generation 使旧句柄失效
+  void release(uint32_t s) {
+    auto &slot = slots[s];
+    slot.generation++;
+    slot.live = false;
+    slot.callable = nullptr;
+    free.push_back(s);
+  }
+
+private:
+  void place(uint32_t i, uint32_t s) {
+    heap[i] = s;
+    slots[s].index = i;
+  }
+
+  void up(uint32_t i) {
+    auto s = heap[i];
+    while (i > 0) {
+      auto parent = (i - 1) / 2;
+      if (slots[heap[parent]].due <= slots[s].due) {
+        break;
+      }
+      place(i, heap[parent]);
+      i = parent;
+    }
+    place(i, s);
+  }
+
+  void down(uint32_t i) {
+    auto s = heap[i];
+    uint32_t n = heap.size();
+    while (true) {
+      auto child = 2 * i + 1;
+      if (child >= n) {
+        break;
+      }
+      if (child + 1 < n && slots[heap[child + 1]].due < slots[heap[child]].due) {
+        child++;
+      }
+      if (slots[s].due <= slots[heap[child]].due) {
+        break;
+      }
+      place(i, heap[child]);
+      i = child;
+    }
+    place(i, s);
+  }
+};
+
+x::Eventloop::TimerService::TimerService(Reactor &r, uint32_t shards)
+    : reactor_(r),
+      timer_fd(timerfd_create(CLOCK_REALTIME, TFD_NONBLOCK | TFD_CLOEXEC)),
+      Shards(shards), shards_(new Shard[shards]), armed_(Disarmed) {
+  if (timer_fd == -1) {
+    LOG(FATAL) << "Failed to create timefd: " << strerror(errno);
+  }
+  if (shards == 0) {
+    LOG(FATAL) << "TimerService needs at least one shard";
+  }
+  // 虚拟时钟只会跳到 Reactor 自己的定时器，这里的 timerfd 用的是真实时间
+  if (reactor_.isVirtualTime()) {
+    LOG(FATAL) << "TimerService does not support virtual time reactor";
+  }
+
+  reactor_.add(timer_fd, Read, [this]() { tick(); }, Urgent);
+  LOG(INFO) << "TimerService created with shards: " << Shards;
+}
+
+x::Eventloop::TimerService::~TimerService() {
+  reactor_.del(timer_fd);
+  close(timer_fd);
+  LOG(INFO) << "TimerService destroyed";
+}
+
+x::Eventloop::Timer x::Eventloop::TimerService::plan(const Callable &c,
+                                                     const Stamp &s,
+                                                     const Gap &g) {
+  auto index = thread_hint % Shards;
+  auto &shard = shards_[index];
+  auto due = s.MilliSecondsSinceEpoch();
+
+  // 与timerfd相同，InValid 的 Stamp 永不触发，返回一个无效句柄
+  Timer t{index, UINT32_MAX, 0};
+  if (!s.isValid()) {
+    return t;
+  }
+
+  {
+    std::lock_guard<std::mutex> a(shard.mutex);
+    if (shard.free.empty()) {
+      t.slot = shard.slots.size();
+      shard.slots.push_back({c, due, g.MilliSeconds(), 0, NoIndex, true});
+    } else {
+      t.slot = shard.free.back();
+      shard.free.pop_back();
+      auto &slot = shard.slots[t.slot];
+      slot.callable = c;
+      slot.due = due;
+      slot.interval = g.MilliSeconds();
+      slot.live = true;
+    }
+    t.generation = shard.slots[t.slot].generation;
+
+    shard.push(t.slot);
+    shard.update();
+  }
+
+  // 只有比已设定的唤醒时间更早时才需要改 timerfd
+  if (due < armed_.load()) {
+    std::lock_guard<std::mutex> a(arm_mutex_);
+    if (due < armed_.load()) {
+      arm(due);
+    }
+  }
+  return t;
+}
+
+bool x::Eventloop::TimerService::cancel(const Timer &t) {
+  if (t.shard >= Shards) {
+    return false;
+  }
+  auto &shard = shards_[t.shard];
+
+  std::lock_guard<std::mutex> a(shard.mutex);
+  if (t.slot >= shard.slots.size()) {
+    return false;
+  }
+  auto &slot = shard.slots[t.slot];
+  if (slot.generation != t.generation || !slot.live) {
+    return false;
+  }
+
+  // 立即从堆中删除并回收slot，大量取消不会堆积到到期时
+  // 已到期等待执行的一次性定时器不在堆中，回收后执行前的检查会跳过它
+  if (slot.index != NoIndex) {
+    shard.erase(slot.index);
+    shard.update();
+  }
+  shard.release(t.slot);
+  return true;
+}
+
+void x::Eventloop::TimerService::arm(uint64_t due) {
+  struct itimerspec tm;
+  memset(&tm, 0, sizeof(tm));
+  if (due != Disarmed) {
+    tm.it_value.tv_sec = due / 1000;
+    tm.it_value.tv_nsec = (due % 1000) * 1000000;
+  }
+  if (timerfd_settime(timer_fd, TFD_TIMER_ABSTIME, &tm, NULL) == -1) {
+    LOG(FATAL) << "Failed to set timerfd time: " << strerror(errno);
+  }
+  armed_ = due;
+}
+
+void x::Eventloop::TimerService::tick() {
+  uint64_t expirations;
+  read(timer_fd, &expirations, sizeof(expirations));
+  {
+    // timerfd 是一次性的，已经触发即为解除状态
+    std::lock_guard<std::mutex> a(arm_mutex_);
+    armed_ = Disarmed;
+  }
+
+  auto now = Stamp::Now().MilliSecondsSinceEpoch();
+  std::vector<Timer> fire;
+
+  for (uint32_t i = 0; i < Shards; i++) {
+    auto &shard = shards_[i];
+    if (shard.earliest.load() > now) {
+      continue; // 未到期的分片不加锁
+    }
+
+    std::lock_guard<std::mutex> a(shard.mutex);
+    while (!shard.heap.empty() && shard.slots[shard.heap.front()].due <= now) {
+      auto s = shard.heap.front();
+      auto &slot = shard.slots[s];
+      shard.erase(0);
+      fire.push_back({i, s, slot.generation});
+
+      if (slot.interval) {
+        // 与timerfd相同，错过的多次到期只触发一次
+        slot.due += ((now - slot.due) / slot.interval + 1) * slot.interval;
+        shard.push(s);
+      }
+    }
+    shard.update();
+  }
+
+  // 重新设定唤醒时间后再检查一次，覆盖与生产者并发 plan 的情况
+  {
+    std::lock_guard<std::mutex> a(arm_mutex_);
+    while (true) {
+      uint64_t earliest = Disarmed;
+      for (uint32_t i = 0; i < Shards; i++) {
+        earliest = std::min(earliest, shards_[i].earliest.load());
+      }
+      if (earliest == armed_.load()) {
+        break;
+      }
+      arm(earliest);
+    }
+  }
+
+  // 前面的回调可能取消了同一轮中后面的定时器，执行前按 generation 再确认一次
+  for (const auto &t : fire) {
+    auto &shard = shards_[t.shard];
+    Callable c;
+    {
+      std::lock_guard<std::mutex> a(shard.mutex);
+      auto &slot = shard.slots[t.slot];
+      if (slot.generation != t.generation || !slot.live) {
+        continue;
+      }
+      if (slot.interval) {
+        c = slot.callable;
+      } else {
+        c = std::move(slot.callable);
+        shard.release(t.slot);
+      }
+    }
+    c();
+  }
+}
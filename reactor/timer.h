@@ -0,0 +1,51 @@
+#pragma once
+#include "reactor.h"
+#include <memory>
+
+namespace x {
+namespace Eventloop {
+
+// 多线程高频 plan 定时器时，Reactor::plan 会在 mutex_ 上串行
+// TimerService 按生产者线程分片，每片一个小顶堆和一把几乎无竞争的锁，
+// Reactor 所在线程在 timerfd 触发时只合并已到期的分片，回调在 Reactor 线程执行
+// 只在新定时器早于当前最早的定时器时才会 timerfd_settime
+// 基于真实时间，不能用于 virtual_time 的 Reactor
+
+// 定时器句柄，generation 不匹配即已失效，可安全地重复 cancel
+class Timer {
+public:
+  uint32_t shard;
+  uint32_t slot;
+  uint32_t generation;
+};
+
+class TimerService {
+public:
+  TimerService(const TimerService &) = delete;
+  TimerService &operator=(const TimerService &) = delete;
+
+  // Owner thread call only
+  TimerService(Reactor &, uint32_t shards = 32);
+  ~TimerService();
+
+  // any thread
+  Timer plan(const Callable &, const Stamp &, const Gap & = Gap::InValid());
+  // 立即回收；同一轮已到期但尚未执行的也不再执行
+  // 已触发的一次性定时器或已取消的返回false
+  bool cancel(const Timer &);
+
+protected:
+  class Shard;
+
+  void tick();
+  void arm(uint64_t); // 需持有arm_mutex_
+
+  Reactor &reactor_;
+  const int timer_fd;
+  const uint32_t Shards;
+  std::unique_ptr<Shard[]> shards_;
+  std::atomic<uint64_t> armed_;
+  std::mutex arm_mutex_;
+};
+}; // namespace Eventloop
+}; // namespace x
@@ -1,5 +1,6 @@
 #include "time.h"
 #include <assert.h>
+#include <atomic>
 #include <chrono>
 #include <iomanip>
 static constexpr uint8_t days_in_month[13] = {0,  31, 28, 31, 30, 31, 30,
@@ -26,6 +27,14 @@ static uint64_t now_milliseconds_since_epoch() {
       .count();
 }
 
+static std::atomic<uint64_t> virtual_milliseconds_since_epoch{0};
+
+static uint64_t virtual_now_milliseconds_since_epoch() {
+  return virtual_milliseconds_since_epoch.load(std::memory_order_relaxed);
+}
+
+static std::atomic<x::time::Clock> clock_source{now_milliseconds_since_epoch};
+
 static uint64_t DateTimeToMilliSeconds(int year, int month, int day, int hour,
                                        int minute, int second,
                                        int millisecond) {
@@ -72,7 +81,7 @@ constexpr bool x::time::isValidDateTime(int year, int month, int day, int hour,
 x::time::Stamp::Stamp(uint64_t m) : milliseconds_since_epoch(m) {}
 
 x::time::Stamp x::time::Stamp::Now() {
-  return Stamp(now_milliseconds_since_epoch());
+  return Stamp(clock_source.load(std::memory_order_relaxed)());
 }
 
 x::time::Stamp x::time::Stamp::InValid() { return Stamp(0); }
@@ -213,3 +222,32 @@ std::string x::time::GapView::toString() const {
       << std::setw(3) << std::setfill('0') << millisecond;
   return oss.str();
 }
+
+void x::time::setClock(Clock c) {
+  clock_source = c ? c : now_milliseconds_since_epoch;
+}
+
+x::time::Clock x::time::getClock() { return clock_source; }
+
+void x::time::VirtualClock::Enable(const Stamp &s) {
+  virtual_milliseconds_since_epoch = s.MilliSecondsSinceEpoch();
+  setClock(virtual_now_milliseconds_since_epoch);
+}
+
+void x::time::VirtualClock::Disable() { setClock(); }
+
+bool x::time::VirtualClock::isEnabled() {
+  return getClock() == virtual_now_milliseconds_since_epoch;
+}
+
+void x::time::VirtualClock::Set(const Stamp &s) {
+  auto m = s.MilliSecondsSinceEpoch();
+  auto now = virtual_milliseconds_since_epoch.load();
+  while (now < m &&
+         !virtual_milliseconds_since_epoch.compare_exchange_weak(now, m)) {
+  }
+}
+
+void x::time::VirtualClock::Advance(const Gap &g) {
+  virtual_milliseconds_since_epoch += g.MilliSeconds();
+}
@@ -83,5 +83,20 @@ protected:
 
 constexpr bool isValidDateTime(int year, int month, int day, int hour,
                                int minute, int second, int millisecond);
+
+// 时钟源，返回毫秒时间戳，Stamp::Now() 经由它取时间
+using Clock = uint64_t (*)();
+void setClock(Clock = nullptr); // nullptr 恢复系统时钟
+Clock getClock();
+
+// 虚拟时钟，时间只在 Set/Advance 时前进，用于测试
+class VirtualClock {
+public:
+  static void Enable(const Stamp & = Stamp::Now());
+  static void Disable();
+  static bool isEnabled();
+  static void Set(const Stamp &); // 不会倒退
+  static void Advance(const Gap &);
+};
 }; // namespace time
 }; // namespace x